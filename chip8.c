@@ -1,10 +1,119 @@
 #include "chip8.h"
-#include "display.h"
+#include "trace.h"
 #include <SDL2/SDL.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+static struct Page* new_page(size_t size) {
+    struct Page* page = calloc(1, sizeof(struct Page) + size);
+    if (page) {
+        page->refs = 1;
+    }
+    return page;
+}
+
+static void release_page(struct Page* page) {
+    if (page && --page->refs == 0) {
+        free(page);
+    }
+}
+
+// Gives the emulator its own copy of a page if it is still shared with a fork.
+// Aborts when out of memory since writing to the shared page would corrupt the other emulators
+static void own_page(struct Page** page, uint8_t** data, size_t size) {
+    if ((*page)->refs == 1) {
+        return;
+    }
+    struct Page* copy = new_page(size);
+    if (!copy) {
+        printf("Out of memory\n");
+        abort();
+    }
+    memcpy(copy->data, (*page)->data, size);
+    (*page)->refs--;
+    *page = copy;
+    *data = copy->data;
+}
+
+// Zeroed and ready for initialize; use destroy_chip8 rather than free
+struct Chip8* create_chip8(void) {
+    struct Chip8* emulator = calloc(1, sizeof(struct Chip8));
+    if (!emulator) {
+        return NULL;
+    }
+    emulator->memory_page = new_page(MEMORY_SIZE);
+    emulator->display_page = new_page(DISPLAY_SIZE);
+    if (!emulator->memory_page || !emulator->display_page) {
+        destroy_chip8(emulator);
+        return NULL;
+    }
+    emulator->memory = emulator->memory_page->data;
+    emulator->display = emulator->display_page->data;
+    return emulator;
+}
+
+void destroy_chip8(struct Chip8* emulator) {
+    if (!emulator) {
+        return;
+    }
+    release_page(emulator->memory_page);
+    release_page(emulator->display_page);
+    free(emulator);
+}
+
+// Copies the registers and shares memory and display until either emulator writes to them.
+// The trace is not shared since two emulators writing into one ring would interleave
+struct Chip8* fork_chip8(struct Chip8* emulator) {
+    struct Chip8* fork = malloc(sizeof(struct Chip8));
+    if (!fork) {
+        return NULL;
+    }
+    *fork = *emulator;
+    fork->trace = NULL;
+    fork->memory_page->refs++;
+    fork->display_page->refs++;
+    return fork;
+}
+
+// A page the emulator owns is overwritten in place so resetting in a loop doesn't allocate; a shared one is swapped for template's
+static void reset_page(struct Page** page, uint8_t** data, struct Page* template, size_t size) {
+    if (*page != template) {
+        if ((*page)->refs == 1) {
+            memcpy((*page)->data, template->data, size);
+        } else {
+            (*page)->refs--;
+            template->refs++;
+            *page = template;
+        }
+    }
+    *data = (*page)->data;
+}
+
+// Puts the emulator back to the state of template (usually a fresh emulator with the rom loaded) with a bulk copy
+void reset_chip8(struct Chip8* emulator, struct Chip8* template) {
+    struct Trace* trace = emulator->trace;
+    struct Page* memory_page = emulator->memory_page;
+    struct Page* display_page = emulator->display_page;
+    *emulator = *template;
+    emulator->trace = trace;
+    emulator->memory_page = memory_page;
+    emulator->display_page = display_page;
+    reset_page(&emulator->memory_page, &emulator->memory, template->memory_page, MEMORY_SIZE);
+    reset_page(&emulator->display_page, &emulator->display, template->display_page, DISPLAY_SIZE);
+}
+
+// Must be called before writing to memory or display so writes don't show up in forks
+void own_memory(struct Chip8* emulator) {
+    own_page(&emulator->memory_page, &emulator->memory, MEMORY_SIZE);
+}
+
+void own_display(struct Chip8* emulator) {
+    own_page(&emulator->display_page, &emulator->display, DISPLAY_SIZE);
+}
+
 // Can I just have a global variable since I only plan to have one emulator struct in memory at a time?
 void initialize(struct Chip8* emulator) {
     emulator->opcode = 0;
@@ -15,8 +124,9 @@ void initialize(struct Chip8* emulator) {
     emulator->delay_timer = 0;
     emulator->running = true;
     emulator->hires = false;
+    emulator->cycles = 0;
 
-    uint8_t font[] = {
+    static const uint8_t font[] = {
         0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
         0x20, 0x60, 0x20, 0x20, 0x70, // 1
         0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
@@ -35,7 +145,7 @@ void initialize(struct Chip8* emulator) {
         0xF0, 0x80, 0xF0, 0x80, 0x80  // F
     };
 
-    uint16_t font10[] = {
+    static const uint16_t font10[] = {
         0xC67C, 0xDECE, 0xF6D6, 0xC6E6, 0x007C, // 0
         0x3010, 0x30F0, 0x3030, 0x3030, 0x00FC, // 1
         0xCC78, 0x0CCC, 0x3018, 0xCC60, 0x00FC, // 2
@@ -54,27 +164,21 @@ void initialize(struct Chip8* emulator) {
         0x66FE, 0x6462, 0x647C, 0x6060, 0x00F0  // F
     };
 
-    for (int i = 0; i < MEMORY_SIZE; i++) {
-        emulator->memory[i] = 0;
-    }
+    own_memory(emulator);
+    own_display(emulator);
+    memset(emulator->memory, 0, MEMORY_SIZE);
+    memset(emulator->display, 0, DISPLAY_SIZE);
+    memset(emulator->V, 0, sizeof(emulator->V));
+    memset(emulator->key, 0, sizeof(emulator->key));
+    memset(emulator->stack, 0, sizeof(emulator->stack));
+    memset(emulator->flags, 0, sizeof(emulator->flags));
 
-    for (int i = 0; i < DISPLAY_SIZE; i++) {
-        emulator->display[i] = 0;
-    }
-
-    for (int i = 0; i < REGISTER_SIZE; i++) {
-        emulator->V[i] = 0;
-        emulator->key[i] = 0;
-        emulator->stack[i] = 0;
-        emulator->flags[i] = 0;
-    }
+    memcpy(emulator->memory, font, sizeof(font));
 
+    // Each word holds two rows, low byte first, so the 10 row font ends up in memory 80 to 239
     for (int i = 0; i < 80; i++) {
-        emulator->memory[i] = font[i];
-    }
-
-    for (int i = 80; i < 160; i++) {
-        emulator->memory[i] = font10[i];
+        emulator->memory[80 + 2 * i] = font10[i] & 0xFF;
+        emulator->memory[80 + 2 * i + 1] = font10[i] >> 8;
     }
 
     srand(time(NULL));
@@ -87,6 +191,7 @@ bool read_to_memory(char* filename, struct Chip8* emulator) {
         return false;
     }
 
+    own_memory(emulator);
     uint8_t buffer;
     int c = 0x200;
     while (fread(&buffer, sizeof(uint8_t), 1, rom) > 0) {
@@ -101,6 +206,27 @@ bool read_to_memory(char* filename, struct Chip8* emulator) {
     return true;
 }
 
+// Same as read_to_memory for a rom that is already in a buffer
+bool load_to_memory(const uint8_t* data, size_t size, struct Chip8* emulator) {
+    if (size > MEMORY_SIZE - 0x200) {
+        printf("Rom too big\n");
+        return false;
+    }
+    own_memory(emulator);
+    memcpy(emulator->memory + 0x200, data, size);
+    return true;
+}
+
+void clear_display(uint8_t display[]) {
+    memset(display, 0, DISPLAY_SIZE);
+}
+
+// Opcodes that don't decode to anything are skipped, but dump the trace since the rom has probably gone wrong
+static void invalid_opcode(struct Chip8* emulator) {
+    printf("invalid opcode!!!!\n");
+    if (emulator->trace) trace_dump_invalid(emulator->trace);
+}
+
 bool decode_execute(uint16_t code, struct Chip8* emulator, struct SDLPack* SDLPack) {
     int u;
     uint16_t nnn = code & 0x0FFF;
@@ -117,6 +243,7 @@ bool decode_execute(uint16_t code, struct Chip8* emulator, struct SDLPack* SDLPa
             switch (code & 0x0FFF) {
                 // 00E0 clears display
                 case 0x00E0:
+                    own_display(emulator);
                     clear_display(emulator->display);
                     break;
                 // 00EE RET from subroutine
@@ -126,6 +253,7 @@ bool decode_execute(uint16_t code, struct Chip8* emulator, struct SDLPack* SDLPa
                     break;
                 // 00FB Shifts display to the right four pixels (2 in lores mode)
                 case 0x00FB:
+                    own_display(emulator);
                     for (int r = 0; r < 64; r++) {
                         for (int c = 127; c >= 0; c--) {
                             int pos = r * 128 + c;
@@ -137,6 +265,7 @@ bool decode_execute(uint16_t code, struct Chip8* emulator, struct SDLPack* SDLPa
                     break;
                 // 00FC shifts display four to the left (2 in lores)
                 case 0x00FC:
+                    own_display(emulator);
                     for (int r = 0; r < 64; r++) {
                         for (int c = 0; c + 4 < 128; c++) {
                             int pos = r * 128 + c;
@@ -158,13 +287,11 @@ bool decode_execute(uint16_t code, struct Chip8* emulator, struct SDLPack* SDLPa
                 // 00CN Shifts display down by N (N/2 in lores)
                 // 00C0 is technically not a valid opcode
                 default:
-                    for (int r = 63; r - n >= 0; r--) {
-                        for (int c = 127; c >= 0; c--) {
-                            int pos = r * 128 + c;
-                            emulator->display[pos] = emulator->display[pos - 128 * n];
-                            emulator->display[pos - 128 * n] = 0;
-                        }
-                    }
+                    // Every 0NNN not handled above ends up here, so move whole rows at once rather than pixel by pixel.
+                    // With N = 0 the old loop moved each row onto itself and then cleared it, so the display is blanked
+                    own_display(emulator);
+                    memmove(emulator->display + 128 * n, emulator->display, 128 * (64 - n));
+                    memset(emulator->display, 0, 128 * (n ? n : 64));
                     break;
             }
             break;
@@ -284,6 +411,9 @@ bool decode_execute(uint16_t code, struct Chip8* emulator, struct SDLPack* SDLPa
                             break;
                     }
                     break;
+                default:
+                    invalid_opcode(emulator);
+                    break;
             }
             break;
         // 9XY0 skip next opcode if vX != vY
@@ -314,6 +444,7 @@ bool decode_execute(uint16_t code, struct Chip8* emulator, struct SDLPack* SDLPa
             emulator->V[(code & 0x0F00) >> 8] = r & nn;
             break;
         case 0xD000:
+            own_display(emulator);
             switch (code & 0x000F) {
                 // DXY0 draw 16x16 pixel sprite at position vX, vY with data starting at the address in I, I is not changed 
                 case 0:
@@ -419,12 +550,16 @@ bool decode_execute(uint16_t code, struct Chip8* emulator, struct SDLPack* SDLPa
                         emulator->pc += 2;
                     }
                     break;
+                default:
+                    invalid_opcode(emulator);
+                    break;
             }
             break;
         case 0xF000:
             switch (code & 0x00FF) {
                 // FX33 write the value of vX as BCD value at the addresses I, I+1 and I+2
                 case 0x0033:
+                    own_memory(emulator);
                     uint8_t h = vx / 100;
                     uint8_t t = (vx % 100) / 10;
                     uint8_t d = vx % 10;
@@ -435,6 +570,7 @@ bool decode_execute(uint16_t code, struct Chip8* emulator, struct SDLPack* SDLPa
                 // FX55 write the content of v0 to vX at the memory pointed to by I, I is incremented by X+1 
                 // CHIP-48/SCHIP1.0 increment I only by X, SCHIP1.1/SCHIP-MODERN not at all
                 case 0x0055:
+                    own_memory(emulator);
                     uint8_t l = (code & 0x0F00) >> 8;
                     switch (emulator->schip) {
                         case true:
@@ -494,9 +630,9 @@ bool decode_execute(uint16_t code, struct Chip8* emulator, struct SDLPack* SDLPa
                 case 0x0029:
                     emulator->I = (vx & 0xF) * 5;
                     break;
-                // FX30 set I to the 10 lines high hex sprite for the lowest nibble in vX
+                // FX30 set I to the 10 lines high hex sprite for the lowest nibble in vX (stored after the 5 line font)
                 case 0x0030:                        
-                    emulator->I = (vx & 0xF) * 10;
+                    emulator->I = 80 + (vx & 0xF) * 10;
                     break;
                 // FX75 store the content of the registers v0 to vX into flags storage (outside of the addressable ram)
                 // These should be continuous between emulator startups - original hardware was between program startups
@@ -514,10 +650,13 @@ bool decode_execute(uint16_t code, struct Chip8* emulator, struct SDLPack* SDLPa
                         emulator->V[i] = emulator->flags[i];
                     }
                     break;
+                default:
+                    invalid_opcode(emulator);
+                    break;
             }
             break;
         default:
-            printf("invalid opcode!!!!\n");
+            invalid_opcode(emulator);
             break;
     }
     return true;
@@ -0,0 +1,120 @@
+#include "disasm.h"
+#include <stdio.h>
+
+// Which fields of the opcode are printed after the mnemonic
+enum Operands {
+    NONE,
+    NNN,
+    N,
+    X,
+    X_NN,
+    X_Y,
+    X_Y_N,
+    // LD Vx, <special> reads a special register into vX; LD <special>, Vx writes vX to it
+    LOAD_X,
+    STORE_X,
+};
+
+struct Mnemonic {
+    uint16_t mask;
+    uint16_t match;
+    const char* name;
+    enum Operands operands;
+    // The special register for LOAD_X and STORE_X
+    const char* special;
+};
+
+// Checked in order, so more specific masks have to come before the ones they overlap with
+static const struct Mnemonic mnemonics[] = {
+    {0xFFFF, 0x00E0, "CLS",  NONE, NULL},
+    {0xFFFF, 0x00EE, "RET",  NONE, NULL},
+    {0xFFFF, 0x00FB, "SCR",  NONE, NULL},
+    {0xFFFF, 0x00FC, "SCL",  NONE, NULL},
+    {0xFFFF, 0x00FD, "EXIT", NONE, NULL},
+    {0xFFFF, 0x00FE, "LOW",  NONE, NULL},
+    {0xFFFF, 0x00FF, "HIGH", NONE, NULL},
+    // decode_execute runs every other 0NNN as 00CN with N from the low nibble, so print what actually executed
+    {0xF000, 0x0000, "SCD",  N, NULL},
+    {0xF000, 0x1000, "JP",   NNN, NULL},
+    {0xF000, 0x2000, "CALL", NNN, NULL},
+    {0xF000, 0x3000, "SE",   X_NN, NULL},
+    {0xF000, 0x4000, "SNE",  X_NN, NULL},
+    {0xF00F, 0x5000, "SE",   X_Y, NULL},
+    {0xF000, 0x6000, "LD",   X_NN, NULL},
+    {0xF000, 0x7000, "ADD",  X_NN, NULL},
+    {0xF00F, 0x8000, "LD",   X_Y, NULL},
+    {0xF00F, 0x8001, "OR",   X_Y, NULL},
+    {0xF00F, 0x8002, "AND",  X_Y, NULL},
+    {0xF00F, 0x8003, "XOR",  X_Y, NULL},
+    {0xF00F, 0x8004, "ADD",  X_Y, NULL},
+    {0xF00F, 0x8005, "SUB",  X_Y, NULL},
+    {0xF00F, 0x8006, "SHR",  X_Y, NULL},
+    {0xF00F, 0x8007, "SUBN", X_Y, NULL},
+    {0xF00F, 0x800E, "SHL",  X_Y, NULL},
+    {0xF00F, 0x9000, "SNE",  X_Y, NULL},
+    {0xF000, 0xA000, "LD I,", NNN, NULL},
+    // SCHIP jumps to XNN + vX instead; traces don't record the mode so this always prints the chip8 form
+    {0xF000, 0xB000, "JP V0,", NNN, NULL},
+    {0xF000, 0xC000, "RND",  X_NN, NULL},
+    {0xF000, 0xD000, "DRW",  X_Y_N, NULL},
+    {0xF0FF, 0xE09E, "SKP",  X, NULL},
+    {0xF0FF, 0xE0A1, "SKNP", X, NULL},
+    {0xF0FF, 0xF007, "LD",   LOAD_X,  "DT"},
+    {0xF0FF, 0xF00A, "LD",   LOAD_X,  "K"},
+    {0xF0FF, 0xF015, "LD",   STORE_X, "DT"},
+    {0xF0FF, 0xF018, "LD",   STORE_X, "ST"},
+    {0xF0FF, 0xF01E, "ADD",  STORE_X, "I"},
+    {0xF0FF, 0xF029, "LD",   STORE_X, "F"},
+    {0xF0FF, 0xF030, "LD",   STORE_X, "HF"},
+    {0xF0FF, 0xF033, "LD",   STORE_X, "B"},
+    {0xF0FF, 0xF055, "LD",   STORE_X, "[I]"},
+    {0xF0FF, 0xF065, "LD",   LOAD_X,  "[I]"},
+    {0xF0FF, 0xF075, "LD",   STORE_X, "R"},
+    {0xF0FF, 0xF085, "LD",   LOAD_X,  "R"},
+};
+
+void disassemble(uint16_t code, char* out, size_t size) {
+    uint16_t nnn = code & 0x0FFF;
+    uint8_t x = (code & 0x0F00) >> 8;
+    uint8_t y = (code & 0x00F0) >> 4;
+    uint8_t nn = code & 0x00FF;
+    uint8_t n = code & 0x000F;
+
+    for (size_t i = 0; i < sizeof(mnemonics) / sizeof(mnemonics[0]); i++) {
+        const struct Mnemonic* m = &mnemonics[i];
+        if ((code & m->mask) != m->match) {
+            continue;
+        }
+        switch (m->operands) {
+            case NONE:
+                snprintf(out, size, "%s", m->name);
+                break;
+            case NNN:
+                snprintf(out, size, "%s %03X", m->name, nnn);
+                break;
+            case N:
+                snprintf(out, size, "%s %X", m->name, n);
+                break;
+            case X:
+                snprintf(out, size, "%s V%X", m->name, x);
+                break;
+            case X_NN:
+                snprintf(out, size, "%s V%X, %02X", m->name, x, nn);
+                break;
+            case X_Y:
+                snprintf(out, size, "%s V%X, V%X", m->name, x, y);
+                break;
+            case X_Y_N:
+                snprintf(out, size, "%s V%X, V%X, %X", m->name, x, y, n);
+                break;
+            case LOAD_X:
+                snprintf(out, size, "%s V%X, %s", m->name, x, m->special);
+                break;
+            case STORE_X:
+                snprintf(out, size, "%s %s, V%X", m->name, m->special, x);
+                break;
+        }
+        return;
+    }
+    snprintf(out, size, "DW %04X", code);
+}
@@ -1,5 +1,7 @@
 #include "chip8.h"
 #include "display.h"
+#include "timing.h"
+#include "trace.h"
 #include <SDL2/SDL.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -8,9 +10,9 @@
 #include <time.h>
 
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        printf("./emulator <rom> <mode>\n");
-        printf("mode s = schip, c = chip8");
+    if (argc < 3 || argc > 5) {
+        printf("./emulator <rom> <mode> [t] [v]\n");
+        printf("mode s = schip, c = chip8, t = record a trace to %s, v = COSMAC VIP timing", TRACE_FILE);
         return 1;
     }
 
@@ -20,7 +22,7 @@ int main(int argc, char* argv[]) {
         printf("Unable to create SDL environment");
         return 1;
     }
-    struct Chip8 *emulator = malloc(sizeof(struct Chip8));
+    struct Chip8 *emulator = create_chip8();
     if (!emulator) {
         printf("Unable to create emulator");
         return 1;
@@ -36,6 +38,24 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    emulator->trace = NULL;
+    emulator->vip_timing = false;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "t") == 0 && !emulator->trace) {
+            emulator->trace = create_trace();
+            if (!emulator->trace) {
+                printf("Unable to create trace");
+                return 1;
+            }
+            trace_on_signal(emulator->trace);
+        } else if (strcmp(argv[i], "v") == 0) {
+            emulator->vip_timing = true;
+        } else {
+            printf("t = record a trace to %s, v = COSMAC VIP timing", TRACE_FILE);
+            return 1;
+        }
+    }
+
     bool SDLsetup = setup(SDLPack);
     if (!SDLsetup) {
         printf("Unable to create SDL environment");
@@ -79,21 +99,47 @@ int main(int argc, char* argv[]) {
         }
 
         // Better to fetch -> increment -> execute. Incrementing inside opcodes is unexpected
+        // The frame budget is spent in cycles; fast mode charges 1 per opcode so it runs 33 opcodes a frame
         if (!emulator->waiting) {
-            for (int i = 0; i < 33; i++) {
+            emulator->cycles += emulator->vip_timing ? VIP_FRAME_CYCLES : FAST_FRAME_CYCLES;
+            while (emulator->cycles > 0) {
                 emulator->draw = false;
                 emulator->opcode = emulator->memory[emulator->pc] << 8 | emulator->memory[emulator->pc + 1];
+                if (emulator->trace) trace_fetch(emulator->trace, emulator->pc, emulator->opcode, emulator->I, emulator->V);
+                int cost = emulator->vip_timing ? cycle_cost(emulator->opcode, emulator) : 1;
+                emulator->cycles -= cost;
                 emulator->pc += 2;
                 decode_execute(emulator->opcode, emulator, SDLPack);
-                update_display(emulator, SDLPack);
+                if (emulator->trace) trace_retire(emulator->trace, emulator->I, emulator->V);
+                // VIP mode runs hundreds of opcodes a frame, too many to render after each one
+                if (!emulator->vip_timing) {
+                    update_display(emulator, SDLPack);
+                }
+                // On the VIP a draw waits for vblank before drawing, so whatever is left of this frame is lost
+                // and the sprite's cost comes out of the next one
+                if (emulator->draw && emulator->vip_timing) {
+                    emulator->cycles = -cost;
+                    break;
+                }
+                // Otherwise an overrun still carries over
                 if (emulator->waiting || emulator->draw) {
+                    if (emulator->cycles > 0) {
+                        emulator->cycles = 0;
+                    }
                     break;
                 }
             }
+            if (emulator->vip_timing) {
+                update_display(emulator, SDLPack);
+            }
         }
         SDL_Delay(16);
     }
-    free(emulator);
+    if (emulator->trace) {
+        trace_off_signal();
+        free(emulator->trace);
+    }
+    destroy_chip8(emulator);
     free(SDLPack);
     SDL_DestroyWindow(SDLPack->window);
     SDL_Quit();
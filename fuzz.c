@@ -0,0 +1,61 @@
+#include "chip8.h"
+#include "timing.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Enough for loops and subroutines to get going while keeping each input well under a millisecond
+#define FUZZ_STEPS 1000
+
+static struct Chip8* template;
+static struct Chip8* emulator;
+
+int LLVMFuzzerInitialize(int* argc, char*** argv) {
+    (void)argc;
+    (void)argv;
+    template = create_chip8();
+    emulator = create_chip8();
+    if (!template || !emulator) {
+        abort();
+    }
+    initialize(template);
+    return 0;
+}
+
+// Headless copy of the loop in emu.c: no display updates, timers tick every frame's worth of opcodes
+static void run(const uint8_t* data, size_t size, bool schip) {
+    // initialize seeds from the clock; reseeding for every run keeps CXNN the same when a crash is replayed on its own
+    srand(0);
+    reset_chip8(emulator, template);
+    emulator->schip = schip;
+    load_to_memory(data, size, emulator);
+
+    for (int i = 0; i < FUZZ_STEPS && !emulator->waiting; i++) {
+        if (i % FAST_FRAME_CYCLES == 0) {
+            if (emulator->sound_timer > 0) {
+                emulator->sound_timer--;
+            }
+            if (emulator->delay_timer > 0) {
+                emulator->delay_timer--;
+            }
+        }
+        emulator->opcode = emulator->memory[emulator->pc] << 8 | emulator->memory[emulator->pc + 1];
+        // Running off into empty memory decodes as 00C0, which rewrites the whole display every step.
+        // 00C0 itself is still reachable when the rom contains it
+        if (emulator->opcode == 0x0000) {
+            break;
+        }
+        emulator->pc += 2;
+        decode_execute(emulator->opcode, emulator, NULL);
+    }
+}
+
+// Each input is run as both chip8 and SCHIP since most of the quirks are switched on emulator->schip
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size > MEMORY_SIZE - 0x200) {
+        return 0;
+    }
+    run(data, size, false);
+    run(data, size, true);
+    return 0;
+}
@@ -2,8 +2,16 @@
 #include <SDL2/SDL.h>
 #include <stdbool.h>
 
+struct Chip8* create_chip8(void);
+void destroy_chip8(struct Chip8* emulator);
+struct Chip8* fork_chip8(struct Chip8* emulator);
+void reset_chip8(struct Chip8* emulator, struct Chip8* template);
+void own_memory(struct Chip8* emulator);
+void own_display(struct Chip8* emulator);
 void initialize(struct Chip8* emulator);
 bool read_to_memory(char* filename, struct Chip8* emulator);
+bool load_to_memory(const uint8_t* data, size_t size, struct Chip8* emulator);
+void clear_display(uint8_t display[]);
 bool decode_execute(uint16_t code, struct Chip8* emulator, struct SDLPack* SDLPack);
 int to_key(SDL_KeyCode key);
 bool is_in_bounds(int v1, int v2);
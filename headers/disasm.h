@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+void disassemble(uint16_t code, char* out, size_t size);
@@ -4,5 +4,4 @@
 
 bool setup(struct SDLPack* SDLPack);
 void update_display(struct Chip8* emulator, struct SDLPack* SDLPack);
-void clear_display(uint8_t display[]);
 void to_pixels(uint8_t display[], uint32_t buffer[]);
\ No newline at end of file
@@ -8,12 +8,23 @@
 #define DISPLAY_SIZE (128 * 64)
 #define REGISTER_SIZE 16
 
+struct Trace;
+
+// Memory and display live in refcounted pages so a forked emulator shares them until one side writes.
+// Not thread safe - forks of the same emulator have to stay on one thread
+struct Page {
+    int refs;
+    uint8_t data[];
+};
+
 struct Chip8 {
-    uint8_t memory[MEMORY_SIZE];
+    // Points into memory_page; call own_memory before writing
+    uint8_t* memory;
     uint8_t V[REGISTER_SIZE];
     // Consider moving flags register to separate file to mimick original behaviour
     uint8_t flags[REGISTER_SIZE];
-    uint8_t display[DISPLAY_SIZE];
+    // Points into display_page; call own_display before writing
+    uint8_t* display;
     uint16_t opcode;
     uint16_t wait_register;
     uint16_t I;
@@ -28,6 +39,14 @@ struct Chip8 {
     bool draw;
     bool schip;
     bool hires;
+    // Charge opcodes their COSMAC VIP machine cycles instead of 1 each
+    bool vip_timing;
+    // Budget left this frame; goes negative when the last opcode overran it
+    int cycles;
+    // NULL unless trace mode is on
+    struct Trace* trace;
+    struct Page* memory_page;
+    struct Page* display_page;
 };
 
 struct SDLPack {
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdint.h>
+#include "struct.h"
+
+// Per-opcode costs come from Jackson Sommerich's measurements of the VIP interpreter, see timing.c
+
+// The VIP runs at 1.7609 MHz with 8 clocks per machine cycle, giving 3668 machine cycles per 60Hz frame.
+// The display DMA steals 8 cycles on each of the 128 scanlines, leaving the rest for the interpreter
+#define VIP_FRAME_CYCLES (3668 - 128 * 8)
+// Fast mode charges every opcode 1 so this is the old instructions per frame
+#define FAST_FRAME_CYCLES 33
+
+int cycle_cost(uint16_t code, struct Chip8* emulator);
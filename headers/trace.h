@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Must be a power of two so the write index can wrap with a mask
+#define TRACE_SIZE 4096
+#define TRACE_MASK (TRACE_SIZE - 1)
+#define TRACE_NO_REG 0xFF
+#define TRACE_FILE "trace.bin"
+
+// One fixed-width (8 byte) record per executed opcode, written in host byte order
+struct TraceRecord {
+    uint16_t pc;
+    uint16_t opcode;
+    uint16_t I;
+    uint8_t reg;
+    uint8_t value;
+};
+
+struct Trace {
+    struct TraceRecord records[TRACE_SIZE];
+    uint8_t V[16];
+    uint32_t head;
+    bool pending;
+    // Set once the first invalid opcode has been dumped so later ones don't overwrite it
+    bool dumped_invalid;
+};
+
+struct Trace* create_trace(void);
+void trace_fetch(struct Trace* trace, uint16_t pc, uint16_t opcode, uint16_t I, uint8_t V[]);
+void trace_retire(struct Trace* trace, uint16_t I, uint8_t V[]);
+void trace_dump(struct Trace* trace);
+void trace_dump_invalid(struct Trace* trace);
+void trace_on_signal(struct Trace* trace);
+void trace_off_signal(void);
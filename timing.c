@@ -0,0 +1,115 @@
+#include "timing.h"
+
+// The VIP runs at 1.7609 MHz with 8 clocks per machine cycle, so one machine cycle is about 4.54us
+#define MICROSECONDS(t) (((t) * 2201 + 5000) / 10000)
+
+// A taken skip runs two more INC instructions on the program counter, each 2 machine cycles on the CDP1802
+#define SKIP_CYCLES 4
+
+// The table gives one figure for FX33, FX55 and FX65, but the VIP loops once per register for FX55/FX65 and
+// converts FX33 by repeated subtraction, once per unit of each digit. The published figure is taken as the
+// average over all inputs and split into the fixed FX dispatch (45us, as FX07) plus a part that scales:
+// FX55/FX65 average X+1 is 17/2, and the digits of 0-255 sum to 2382 in total
+#define FX_DISPATCH_US 45
+#define REGISTER_LOOP_US(x) (FX_DISPATCH_US + (605 - FX_DISPATCH_US) * 2 * ((x) + 1) / 17)
+#define BCD_US(digits) (FX_DISPATCH_US + (927 - FX_DISPATCH_US) * 256 * (digits) / 2382)
+
+// DXYN isn't in the table below without the vblank wait, so its cost is built from CDP1802 instruction counts
+// for each part of the VIP interpreter's sprite routine, at 2 machine cycles per instruction. The counts follow the
+// routine's structure (set up the display address from vX/vY, then per row: load the sprite byte, shift it into
+// place, XOR it into the display, check for collision, step to the next line) and are estimates, not cycle exact.
+// Setting up the display pointer and the shift count from vX and vY
+#define DRAW_SETUP_CYCLES (17 * 2)
+// Load, XOR, store, collision check and stepping to the next line for one display byte
+#define DRAW_ROW_CYCLES (7 * 2)
+// An unaligned row spills into a second display byte which needs its own XOR, store and collision check
+#define DRAW_SPILL_CYCLES (5 * 2)
+// The row is shifted right one bit at a time (shift the byte, rotate the carry into the spill byte)
+#define DRAW_SHIFT_CYCLES (2 * 2)
+
+// Execution time of each opcode on the COSMAC VIP interpreter, as measured in Jackson Sommerich's
+// "Chip-8 Instruction Scheduling and Frequency" (https://jackson-s.me/2019/07/13/Chip-8-Instruction-Scheduling-and-Frequency.html).
+// The figures are kept in microseconds as published and indexed by the top nibble.
+// 0 means the cost depends on the rest of the opcode and is worked out in cycle_cost
+static const uint16_t base_cycles[16] = {
+    0,                  // 0NNN
+    MICROSECONDS(105),  // 1NNN
+    MICROSECONDS(105),  // 2NNN
+    0,                  // 3XNN
+    0,                  // 4XNN
+    0,                  // 5XY0
+    MICROSECONDS(27),   // 6XNN
+    MICROSECONDS(45),   // 7XNN
+    MICROSECONDS(200),  // 8XYN
+    0,                  // 9XY0
+    MICROSECONDS(55),   // ANNN
+    MICROSECONDS(105),  // BNNN
+    MICROSECONDS(164),  // CXNN
+    0,                  // DXYN
+    0,                  // EXNN
+    0,                  // FXNN
+};
+
+// Needs to be called before decode_execute since skips, DXYN and FX33 depend on the registers going in
+int cycle_cost(uint16_t code, struct Chip8* emulator) {
+    int cost = base_cycles[code >> 12];
+    if (cost) {
+        return cost;
+    }
+
+    uint8_t vx = emulator->V[(code & 0x0F00) >> 8];
+    uint8_t vy = emulator->V[(code & 0x00F0) >> 4];
+    uint8_t nn = code & 0x00FF;
+    uint8_t n = code & 0x000F;
+    switch (code >> 12) {
+        case 0x0:
+            if (code == 0x00E0) {
+                return MICROSECONDS(109);
+            }
+            // 00EE and machine code calls; the SCHIP opcodes don't exist on the VIP so they are charged the same
+            return MICROSECONDS(105);
+        case 0x3:
+            return MICROSECONDS(55) + (vx == nn ? SKIP_CYCLES : 0);
+        case 0x4:
+            return MICROSECONDS(55) + (vx != nn ? SKIP_CYCLES : 0);
+        case 0x5:
+            return MICROSECONDS(73) + (vx == vy ? SKIP_CYCLES : 0);
+        case 0x9:
+            return MICROSECONDS(73) + (vx != vy ? SKIP_CYCLES : 0);
+        case 0xD:
+            // The published 22734us includes waiting for vblank, which the main loop models by ending the frame
+            // on a draw, so only the drawing itself is charged here
+            if ((vx & 7) == 0) {
+                return DRAW_SETUP_CYCLES + n * DRAW_ROW_CYCLES;
+            }
+            return DRAW_SETUP_CYCLES + n * (DRAW_ROW_CYCLES + DRAW_SPILL_CYCLES + (vx & 7) * DRAW_SHIFT_CYCLES);
+        case 0xE: {
+            bool pressed = emulator->key[vx & 0xF] == 1;
+            bool skip = (nn == 0x9E) ? pressed : !pressed;
+            return MICROSECONDS(73) + (skip ? SKIP_CYCLES : 0);
+        }
+        case 0xF:
+            switch (nn) {
+                // FX0A is charged the same as FX07; the time spent waiting is handled by the waiting flag
+                case 0x07:
+                case 0x0A:
+                case 0x15:
+                case 0x18:
+                    return MICROSECONDS(45);
+                case 0x1E:
+                    return MICROSECONDS(86);
+                // FX30 is SCHIP only and charged like its 5 line counterpart
+                case 0x29:
+                case 0x30:
+                    return MICROSECONDS(91);
+                case 0x33:
+                    return MICROSECONDS(BCD_US(vx / 100 + (vx / 10) % 10 + vx % 10));
+                case 0x55:
+                case 0x65:
+                    return MICROSECONDS(REGISTER_LOOP_US((code & 0x0F00) >> 8));
+            }
+            // FX75 and FX85 are SCHIP only
+            return MICROSECONDS(45);
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "trace.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Signal handlers can't take arguments so the trace being recorded has to live here
+static struct Trace* active_trace = NULL;
+
+struct Trace* create_trace(void) {
+    struct Trace* trace = calloc(1, sizeof(struct Trace));
+    return trace;
+}
+
+// Called before decode_execute so an opcode that faults is already in the buffer when it is dumped
+void trace_fetch(struct Trace* trace, uint16_t pc, uint16_t opcode, uint16_t I, uint8_t V[]) {
+    struct TraceRecord* record = &trace->records[trace->head & TRACE_MASK];
+    record->pc = pc;
+    record->opcode = opcode;
+    record->I = I;
+    record->reg = TRACE_NO_REG;
+    record->value = 0;
+    memcpy(trace->V, V, sizeof(trace->V));
+    trace->pending = true;
+}
+
+// Called after decode_execute; registers are scanned from v0 so vX is reported ahead of vF when an opcode sets both
+void trace_retire(struct Trace* trace, uint16_t I, uint8_t V[]) {
+    struct TraceRecord* record = &trace->records[trace->head & TRACE_MASK];
+    record->I = I;
+    for (int i = 0; i < 16; i++) {
+        if (V[i] != trace->V[i]) {
+            record->reg = i;
+            record->value = V[i];
+            break;
+        }
+    }
+    trace->head++;
+    trace->pending = false;
+}
+
+// Loops on short writes; gives up on any error other than being interrupted
+static bool write_all(int fd, const void* data, size_t size) {
+    const uint8_t* p = data;
+    while (size > 0) {
+        ssize_t written = write(fd, p, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += written;
+        size -= written;
+    }
+    return true;
+}
+
+// Writes the records oldest first. Only uses open/write so it is safe to call from a signal handler
+void trace_dump(struct Trace* trace) {
+    uint32_t end = trace->head + (trace->pending ? 1 : 0);
+    uint32_t count = end < TRACE_SIZE ? end : TRACE_SIZE;
+    uint32_t start = (end - count) & TRACE_MASK;
+
+    int fd = open(TRACE_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return;
+    }
+    // The ring may wrap, in which case the oldest records are at the end of the array
+    uint32_t first = (start + count > TRACE_SIZE) ? TRACE_SIZE - start : count;
+    if (write_all(fd, &trace->records[start], first * sizeof(struct TraceRecord))) {
+        write_all(fd, &trace->records[0], (count - first) * sizeof(struct TraceRecord));
+    }
+    close(fd);
+}
+
+// Only the first invalid opcode is dumped; it is the one that says what went wrong, and a rom running
+// through data would otherwise rewrite the file every opcode. SIGUSR1 still dumps whenever it is sent
+void trace_dump_invalid(struct Trace* trace) {
+    if (trace->dumped_invalid) {
+        return;
+    }
+    trace_dump(trace);
+    trace->dumped_invalid = true;
+}
+
+static void dump_and_raise(int sig) {
+    // The handler can interrupt code that is about to check errno
+    int saved_errno = errno;
+    if (active_trace) {
+        trace_dump(active_trace);
+    }
+    errno = saved_errno;
+    // SA_RESETHAND restored the default action, so faults still terminate (and core dump) as normal
+    if (sig != SIGUSR1) {
+        raise(sig);
+    }
+}
+
+// Dumps on crashes and on SIGUSR1, which can be sent to grab a trace from a running ROM
+void trace_on_signal(struct Trace* trace) {
+    active_trace = trace;
+
+    struct sigaction fatal = {0};
+    fatal.sa_handler = dump_and_raise;
+    fatal.sa_flags = SA_RESETHAND;
+    sigemptyset(&fatal.sa_mask);
+    sigaction(SIGSEGV, &fatal, NULL);
+    sigaction(SIGBUS, &fatal, NULL);
+    sigaction(SIGFPE, &fatal, NULL);
+    sigaction(SIGABRT, &fatal, NULL);
+
+    struct sigaction dump = {0};
+    dump.sa_handler = dump_and_raise;
+    dump.sa_flags = SA_RESTART;
+    sigemptyset(&dump.sa_mask);
+    sigaction(SIGUSR1, &dump, NULL);
+}
+
+// Puts the default handlers back so the trace can be freed
+void trace_off_signal(void) {
+    signal(SIGSEGV, SIG_DFL);
+    signal(SIGBUS, SIG_DFL);
+    signal(SIGFPE, SIG_DFL);
+    signal(SIGABRT, SIG_DFL);
+    signal(SIGUSR1, SIG_DFL);
+    active_trace = NULL;
+}
@@ -0,0 +1,26 @@
+#include "disasm.h"
+#include "trace.h"
+#include <stdio.h>
+
+int main(int argc, char* argv[]) {
+    char* filename = argc > 1 ? argv[1] : TRACE_FILE;
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        printf("Unable to open %s\n", filename);
+        return 1;
+    }
+
+    struct TraceRecord record;
+    char text[32];
+    printf("PC   OP    INSTRUCTION        I    CHANGED\n");
+    while (fread(&record, sizeof(struct TraceRecord), 1, file) == 1) {
+        disassemble(record.opcode, text, sizeof(text));
+        printf("%03X  %04X  %-17s  %03X", record.pc, record.opcode, text, record.I);
+        if (record.reg != TRACE_NO_REG) {
+            printf("  V%X=%02X", record.reg, record.value);
+        }
+        printf("\n");
+    }
+    fclose(file);
+    return 0;
+}